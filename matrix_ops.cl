@@ -0,0 +1,136 @@
+// OpenCL kernels for dense matrix operations built on top of the vector kernels
+// All matrices hold floats. TILE and GEMV_WG are set by the host with
+// -DTILE=<n> -DGEMV_WG=<n>; GEMV_WG must be a power of two.
+
+#ifndef TILE
+#define TILE 16
+#endif
+
+#ifndef GEMV_WG
+#define GEMV_WG 64
+#endif
+
+// Sum the GEMV_WG partial sums of a work-group in local memory and return the
+// total (valid in work-item 0). Must be reached by every work-item in the group.
+inline float reduce_partial_sums(__local float* partial, float acc) {
+    const int lid = get_local_id(0);
+    partial[lid] = acc;
+    barrier(CLK_LOCAL_MEM_FENCE);
+    for (int s = GEMV_WG / 2; s > 0; s >>= 1) {
+        if (lid < s) partial[lid] += partial[lid + s];
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+    return partial[0];
+}
+
+// y = A * x where A is rows x cols in row-major order
+// One work-group of GEMV_WG work-items per output row. The work-items stride
+// across the row, so neighbouring work-items read neighbouring elements and
+// the loads are coalesced; their partial sums are reduced in local memory.
+__kernel void matvec_row_major(const int rows,
+                               const int cols,
+                               __global const float* A,
+                               __global const float* x,
+                               __global float* y) {
+
+    __local float partial[GEMV_WG];
+
+    const int r = get_group_id(0);
+    const int lid = get_local_id(0);
+    if (r >= rows) return;
+
+    __global const float* a = A + (size_t)r * cols;
+    float acc = 0.0f;
+    for (int c = lid; c < cols; c += GEMV_WG) {
+        acc += a[c] * x[c];
+    }
+
+    const float sum = reduce_partial_sums(partial, acc);
+    if (lid == 0) y[r] = sum;
+}
+
+// y = A * x where A is rows x cols in column-major order
+// Neighbouring work-items read neighbouring elements of each column, so the
+// loads are coalesced on GPUs
+__kernel void matvec_col_major(const int rows,
+                               const int cols,
+                               __global const float* A,
+                               __global const float* x,
+                               __global float* y) {
+
+    const int r = get_global_id(0);
+    if (r >= rows) return;
+
+    float acc = 0.0f;
+    for (int c = 0; c < cols; c++) {
+        acc += A[c * rows + r] * x[c];
+    }
+    y[r] = acc;
+}
+
+// y[b] = A[b] * x[b] for b in [0, batch), row-major matrices stored back to back
+// 2-D range of GEMV_WG x 1 work-groups: group dimension 0 walks the rows,
+// dimension 1 walks the batch. Each row is reduced as in matvec_row_major.
+__kernel void batched_gemv(const int rows,
+                           const int cols,
+                           const int batch,
+                           __global const float* A,
+                           __global const float* x,
+                           __global float* y) {
+
+    __local float partial[GEMV_WG];
+
+    const int r = get_group_id(0);
+    const int b = get_global_id(1);
+    const int lid = get_local_id(0);
+    if (r >= rows || b >= batch) return;
+
+    __global const float* a = A + ((size_t)b * rows + r) * cols;
+    __global const float* xb = x + (size_t)b * cols;
+
+    float acc = 0.0f;
+    for (int c = lid; c < cols; c += GEMV_WG) {
+        acc += a[c] * xb[c];
+    }
+
+    const float sum = reduce_partial_sums(partial, acc);
+    if (lid == 0) y[b * rows + r] = sum;
+}
+
+// C = A * B where A is M x K, B is K x N and C is M x N, all row-major
+// Each TILE x TILE work-group stages one tile of A and one tile of B in local
+// memory per step, so every global element is loaded once per work-group
+// instead of once per work-item. Out-of-range elements are padded with zeros.
+__kernel void matmul_tiled(const int M,
+                           const int N,
+                           const int K,
+                           __global const float* A,
+                           __global const float* B,
+                           __global float* C) {
+
+    __local float As[TILE][TILE];
+    __local float Bs[TILE][TILE];
+
+    const int lc = get_local_id(0);
+    const int lr = get_local_id(1);
+    const int col = get_global_id(0);
+    const int row = get_global_id(1);
+
+    float acc = 0.0f;
+    for (int t = 0; t < K; t += TILE) {
+        As[lr][lc] = (row < M && t + lc < K) ? A[row * K + t + lc] : 0.0f;
+        Bs[lr][lc] = (t + lr < K && col < N) ? B[(t + lr) * N + col] : 0.0f;
+        // Wait until the whole tile is loaded before using it
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        for (int k = 0; k < TILE; k++) {
+            acc += As[lr][k] * Bs[k][lc];
+        }
+        // Wait until everyone is done with the tile before overwriting it
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (row < M && col < N) {
+        C[row * N + col] = acc;
+    }
+}
@@ -0,0 +1,731 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <limits.h>
+#include <stdint.h>
+#include <CL/cl.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define PRINT 1
+
+int SZ = 512;     // square matrix dimension (rows = cols = SZ)
+int BATCH = 16;   // number of matrix-vector products in the batched GEMV
+
+// Cache block edge for the CPU matrix multiply (3 float blocks of 64x64 fit in L2)
+constexpr int CPU_BLOCK = 64;
+
+// Rows sharing each load of x, and independent partial sums per row (one
+// 256-bit SIMD register of floats), in the CPU row-major GEMV
+constexpr int GEMV_ROWS = 4;
+constexpr int GEMV_LANES = 8;
+
+// Timed runs per operation, after one untimed warm-up run
+constexpr int TIMING_REPS = 5;
+
+// Fixed set of worker threads reused by every CPU operation, so the timings
+// do not include thread creation and joining
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned num_threads);
+    ~ThreadPool();
+
+    unsigned size() const { return (unsigned)workers.size(); }
+
+    // Split [0, count) into one contiguous chunk per worker, run
+    // fn(start, end) on each and wait for all of them to finish
+    void parallel_for(int count, const std::function<void(int, int)> &fn);
+
+private:
+    void worker_loop(unsigned id);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+    const std::function<void(int, int)> *job = NULL;
+    int job_count = 0;
+    unsigned generation = 0;   // bumped for every parallel_for call
+    unsigned pending = 0;      // workers still running the current job
+    bool stopping = false;
+};
+
+// OpenCL variables
+cl_device_id device_id;
+cl_context context;
+cl_program program;
+cl_command_queue queue;
+int tile = 16;
+int gemv_wg = 256;   // work-items per row in the row-major GEMV kernels
+int err;
+
+// Function declarations
+cl_device_id create_device();
+void setup_openCL_device_context_queue(char *filename);
+cl_program build_program(cl_context ctx, cl_device_id dev, const char *filename, const char *options);
+cl_kernel create_kernel(const char *kernelname);
+size_t kernel_work_group_size(const char *kernelname);
+cl_mem create_buffer(cl_mem_flags flags, size_t count, const float *host);
+void run_kernel(cl_kernel k, cl_uint dims, const size_t *global, const size_t *local);
+void free_memory();
+
+template <typename F> double time_best(F fn);
+float *alloc_matrix(size_t count);
+void init_matrix(float *&A, size_t count);
+bool check_results(const float *result, const float *reference, size_t count);
+void report(const char *name, double flops, double opencl_ms, bool opencl_ok, double cpu_ms, bool cpu_ok);
+size_t round_up(size_t value, size_t multiple);
+
+// Naive single-threaded references used for validation
+void matvec_row_major_ref(const float *A, const float *x, float *y, int rows, int cols);
+void matvec_col_major_ref(const float *A, const float *x, float *y, int rows, int cols);
+void matmul_ref(const float *A, const float *B, float *C, int M, int N, int K);
+
+// Optimized multi-threaded CPU versions
+template <int ROWS> void matvec_rows(const float *A, const float *x, float *y, int cols);
+void matvec_row_block(const float *A, const float *x, float *y, int rows, int cols);
+void matvec_row_major_threaded(ThreadPool &pool, const float *A, const float *x, float *y, int rows, int cols);
+void matvec_col_major_threaded(ThreadPool &pool, const float *A, const float *x, float *y, int rows, int cols);
+void batched_gemv_threaded(ThreadPool &pool, const float *A, const float *x, float *y, int rows, int cols, int batch);
+void matmul_blocked_threaded(ThreadPool &pool, const float *A, const float *B, float *C, int M, int N, int K);
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+        SZ = atoi(argv[1]);
+    if (argc > 2)
+        BATCH = atoi(argv[2]);
+
+    // Kernels index with int, so every matrix and the batched output must stay
+    // below INT_MAX elements; the batched input must fit in size_t bytes
+    if (SZ <= 0 || BATCH <= 0 ||
+        (size_t)SZ * SZ > INT_MAX || (size_t)SZ * BATCH > INT_MAX ||
+        (size_t)BATCH > SIZE_MAX / sizeof(float) / ((size_t)SZ * SZ)) {
+        printf("Usage: %s [matrix_size] [batch]\n", argv[0]);
+        printf("  matrix_size and batch must be positive, with matrix_size^2 and\n");
+        printf("  matrix_size * batch below %d\n", INT_MAX);
+        return 1;
+    }
+
+    unsigned num_threads = std::thread::hardware_concurrency();
+    if (num_threads == 0) num_threads = 4; // default fallback
+    ThreadPool pool(num_threads);
+
+    const size_t n = (size_t)SZ;
+    float *A, *A_col, *B, *x, *A_batch, *x_batch;
+    init_matrix(A, n * n);
+    init_matrix(B, n * n);
+    init_matrix(x, n);
+    init_matrix(A_batch, (size_t)BATCH * n * n);
+    init_matrix(x_batch, (size_t)BATCH * n);
+
+    // Column-major copy of A for the column-major matrix-vector product
+    A_col = alloc_matrix(n * n);
+    for (size_t r = 0; r < n; r++)
+        for (size_t c = 0; c < n; c++)
+            A_col[c * n + r] = A[r * n + c];
+
+    float *y_cl = alloc_matrix(n * BATCH);
+    float *y_cpu = alloc_matrix(n * BATCH);
+    float *y_ref = alloc_matrix(n * BATCH);
+    float *C_cl = alloc_matrix(n * n);
+    float *C_cpu = alloc_matrix(n * n);
+    float *C_ref = alloc_matrix(n * n);
+
+    printf("Matrix Operations Performance Comparison\n");
+    printf("Matrix Size: %d x %d, Batch: %d, Threads: %u\n", SZ, SZ, BATCH, pool.size());
+    printf("Timings: best of %d runs after one warm-up run\n", TIMING_REPS);
+    printf("========================================\n");
+
+    setup_openCL_device_context_queue((char *)"./matrix_ops.cl");
+
+    cl_mem bufA = create_buffer(CL_MEM_READ_ONLY, n * n, A);
+    cl_mem bufAcol = create_buffer(CL_MEM_READ_ONLY, n * n, A_col);
+    cl_mem bufB = create_buffer(CL_MEM_READ_ONLY, n * n, B);
+    cl_mem bufX = create_buffer(CL_MEM_READ_ONLY, n, x);
+    cl_mem bufAbatch = create_buffer(CL_MEM_READ_ONLY, BATCH * n * n, A_batch);
+    cl_mem bufXbatch = create_buffer(CL_MEM_READ_ONLY, BATCH * n, x_batch);
+    cl_mem bufY = create_buffer(CL_MEM_WRITE_ONLY, BATCH * n, NULL);
+    cl_mem bufC = create_buffer(CL_MEM_WRITE_ONLY, n * n, NULL);
+
+    // Row-major GEMV: one work-group of gemv_wg work-items per row.
+    // Column-major GEMV: one work-item per row.
+    size_t global_row_groups[1] = {n * gemv_wg};
+    size_t local_row_groups[1] = {(size_t)gemv_wg};
+    size_t global_rows[1] = {n};
+
+    // ------------------------------------------
+    // Row-major matrix-vector multiply
+    // ------------------------------------------
+    {
+        cl_kernel k = create_kernel("matvec_row_major");
+        clSetKernelArg(k, 0, sizeof(int), (void *)&SZ);
+        clSetKernelArg(k, 1, sizeof(int), (void *)&SZ);
+        clSetKernelArg(k, 2, sizeof(cl_mem), (void *)&bufA);
+        clSetKernelArg(k, 3, sizeof(cl_mem), (void *)&bufX);
+        clSetKernelArg(k, 4, sizeof(cl_mem), (void *)&bufY);
+        double cl_ms = time_best([&] { run_kernel(k, 1, global_row_groups, local_row_groups); });
+        clEnqueueReadBuffer(queue, bufY, CL_TRUE, 0, n * sizeof(float), y_cl, 0, NULL, NULL);
+        clReleaseKernel(k);
+
+        double cpu_ms = time_best([&] { matvec_row_major_threaded(pool, A, x, y_cpu, SZ, SZ); });
+
+        matvec_row_major_ref(A, x, y_ref, SZ, SZ);
+        report("GEMV row-major", 2.0 * n * n, cl_ms, check_results(y_cl, y_ref, n),
+               cpu_ms, check_results(y_cpu, y_ref, n));
+    }
+
+    // ------------------------------------------
+    // Column-major matrix-vector multiply
+    // ------------------------------------------
+    {
+        cl_kernel k = create_kernel("matvec_col_major");
+        clSetKernelArg(k, 0, sizeof(int), (void *)&SZ);
+        clSetKernelArg(k, 1, sizeof(int), (void *)&SZ);
+        clSetKernelArg(k, 2, sizeof(cl_mem), (void *)&bufAcol);
+        clSetKernelArg(k, 3, sizeof(cl_mem), (void *)&bufX);
+        clSetKernelArg(k, 4, sizeof(cl_mem), (void *)&bufY);
+        double cl_ms = time_best([&] { run_kernel(k, 1, global_rows, NULL); });
+        clEnqueueReadBuffer(queue, bufY, CL_TRUE, 0, n * sizeof(float), y_cl, 0, NULL, NULL);
+        clReleaseKernel(k);
+
+        double cpu_ms = time_best([&] { matvec_col_major_threaded(pool, A_col, x, y_cpu, SZ, SZ); });
+
+        matvec_col_major_ref(A_col, x, y_ref, SZ, SZ);
+        report("GEMV col-major", 2.0 * n * n, cl_ms, check_results(y_cl, y_ref, n),
+               cpu_ms, check_results(y_cpu, y_ref, n));
+    }
+
+    // ------------------------------------------
+    // Batched matrix-vector multiply (2-D launch: row groups x batch)
+    // ------------------------------------------
+    {
+        size_t global[2] = {n * gemv_wg, (size_t)BATCH};
+        size_t local[2] = {(size_t)gemv_wg, 1};
+        cl_kernel k = create_kernel("batched_gemv");
+        clSetKernelArg(k, 0, sizeof(int), (void *)&SZ);
+        clSetKernelArg(k, 1, sizeof(int), (void *)&SZ);
+        clSetKernelArg(k, 2, sizeof(int), (void *)&BATCH);
+        clSetKernelArg(k, 3, sizeof(cl_mem), (void *)&bufAbatch);
+        clSetKernelArg(k, 4, sizeof(cl_mem), (void *)&bufXbatch);
+        clSetKernelArg(k, 5, sizeof(cl_mem), (void *)&bufY);
+        double cl_ms = time_best([&] { run_kernel(k, 2, global, local); });
+        clEnqueueReadBuffer(queue, bufY, CL_TRUE, 0, BATCH * n * sizeof(float), y_cl, 0, NULL, NULL);
+        clReleaseKernel(k);
+
+        double cpu_ms = time_best([&] { batched_gemv_threaded(pool, A_batch, x_batch, y_cpu, SZ, SZ, BATCH); });
+
+        for (int b = 0; b < BATCH; b++)
+            matvec_row_major_ref(A_batch + b * n * n, x_batch + b * n, y_ref + b * n, SZ, SZ);
+        report("Batched GEMV", 2.0 * BATCH * n * n, cl_ms, check_results(y_cl, y_ref, BATCH * n),
+               cpu_ms, check_results(y_cpu, y_ref, BATCH * n));
+    }
+
+    // ------------------------------------------
+    // Tiled matrix-matrix multiply (2-D launch in TILE x TILE work-groups)
+    // ------------------------------------------
+    {
+        // Round the range up so every work-group is full; the kernel pads the edges
+        size_t global[2] = {round_up(n, tile), round_up(n, tile)};
+        size_t local[2] = {(size_t)tile, (size_t)tile};
+        cl_kernel k = create_kernel("matmul_tiled");
+        clSetKernelArg(k, 0, sizeof(int), (void *)&SZ);
+        clSetKernelArg(k, 1, sizeof(int), (void *)&SZ);
+        clSetKernelArg(k, 2, sizeof(int), (void *)&SZ);
+        clSetKernelArg(k, 3, sizeof(cl_mem), (void *)&bufA);
+        clSetKernelArg(k, 4, sizeof(cl_mem), (void *)&bufB);
+        clSetKernelArg(k, 5, sizeof(cl_mem), (void *)&bufC);
+        double cl_ms = time_best([&] { run_kernel(k, 2, global, local); });
+        clEnqueueReadBuffer(queue, bufC, CL_TRUE, 0, n * n * sizeof(float), C_cl, 0, NULL, NULL);
+        clReleaseKernel(k);
+
+        double cpu_ms = time_best([&] { matmul_blocked_threaded(pool, A, B, C_cpu, SZ, SZ, SZ); });
+
+        matmul_ref(A, B, C_ref, SZ, SZ, SZ);
+        report("GEMM tiled", 2.0 * n * n * n, cl_ms, check_results(C_cl, C_ref, n * n),
+               cpu_ms, check_results(C_cpu, C_ref, n * n));
+    }
+
+    clReleaseMemObject(bufA);
+    clReleaseMemObject(bufAcol);
+    clReleaseMemObject(bufB);
+    clReleaseMemObject(bufX);
+    clReleaseMemObject(bufAbatch);
+    clReleaseMemObject(bufXbatch);
+    clReleaseMemObject(bufY);
+    clReleaseMemObject(bufC);
+
+    free(A); free(A_col); free(B); free(x); free(A_batch); free(x_batch);
+    free(y_cl); free(y_cpu); free(y_ref);
+    free(C_cl); free(C_cpu); free(C_ref);
+
+    free_memory();
+    return 0;
+}
+
+// Run fn once untimed to absorb lazy driver/JIT work, page faults and cold
+// caches, then return the best of TIMING_REPS runs in milliseconds
+template <typename F>
+double time_best(F fn)
+{
+    fn();
+    double best = 0.0;
+    for (int rep = 0; rep < TIMING_REPS; rep++) {
+        auto t0 = std::chrono::high_resolution_clock::now();
+        fn();
+        auto t1 = std::chrono::high_resolution_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        if (rep == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+float *alloc_matrix(size_t count)
+{
+    float *A = (float *)malloc(sizeof(float) * count);
+    if (A == NULL) {
+        perror("Couldn't allocate host memory");
+        printf("requested %zu floats\n", count);
+        exit(1);
+    }
+    return A;
+}
+
+void init_matrix(float *&A, size_t count)
+{
+    A = alloc_matrix(count);
+
+    for (size_t i = 0; i < count; i++) {
+        A[i] = (rand() % 100) / 100.0f; // values in [0, 1)
+    }
+}
+
+// Compare against the reference with a relative tolerance, since the OpenCL
+// kernels and the CPU row-major/batched GEMV sum in a different order than
+// the naive loops
+bool check_results(const float *result, const float *reference, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (fabsf(result[i] - reference[i]) > 1e-3f * (fabsf(reference[i]) + 1.0f)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void report(const char *name, double flops, double opencl_ms, bool opencl_ok, double cpu_ms, bool cpu_ok)
+{
+    if (PRINT == 0) return;
+
+    printf("%s\n", name);
+    printf("  OpenCL:  %9.3f ms  %8.2f GFLOP/s  %s\n",
+           opencl_ms, flops / (opencl_ms * 1e6), opencl_ok ? "OK" : "MISMATCH");
+    printf("  Threads: %9.3f ms  %8.2f GFLOP/s  %s\n",
+           cpu_ms, flops / (cpu_ms * 1e6), cpu_ok ? "OK" : "MISMATCH");
+}
+
+size_t round_up(size_t value, size_t multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+// ----------------------------
+// Naive reference implementations
+// ----------------------------
+void matvec_row_major_ref(const float *A, const float *x, float *y, int rows, int cols)
+{
+    for (int r = 0; r < rows; r++) {
+        float acc = 0.0f;
+        for (int c = 0; c < cols; c++) {
+            acc += A[(size_t)r * cols + c] * x[c];
+        }
+        y[r] = acc;
+    }
+}
+
+void matvec_col_major_ref(const float *A, const float *x, float *y, int rows, int cols)
+{
+    for (int r = 0; r < rows; r++) {
+        float acc = 0.0f;
+        for (int c = 0; c < cols; c++) {
+            acc += A[(size_t)c * rows + r] * x[c];
+        }
+        y[r] = acc;
+    }
+}
+
+void matmul_ref(const float *A, const float *B, float *C, int M, int N, int K)
+{
+    for (int i = 0; i < M; i++) {
+        for (int j = 0; j < N; j++) {
+            float acc = 0.0f;
+            for (int k = 0; k < K; k++) {
+                acc += A[(size_t)i * K + k] * B[(size_t)k * N + j];
+            }
+            C[(size_t)i * N + j] = acc;
+        }
+    }
+}
+
+// ----------------------------
+// Multi-threaded CPU implementations
+// ----------------------------
+
+ThreadPool::ThreadPool(unsigned num_threads)
+{
+    if (num_threads < 1) num_threads = 1;
+    workers.reserve(num_threads);
+    for (unsigned id = 0; id < num_threads; id++) {
+        workers.emplace_back(&ThreadPool::worker_loop, this, id);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work_ready.notify_all();
+    for (auto &t : workers) t.join();
+}
+
+void ThreadPool::parallel_for(int count, const std::function<void(int, int)> &fn)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    job = &fn;
+    job_count = count;
+    pending = size();
+    generation++;
+    work_ready.notify_all();
+    work_done.wait(lock, [this] { return pending == 0; });
+    job = NULL;
+}
+
+void ThreadPool::worker_loop(unsigned id)
+{
+    unsigned seen = 0;
+    for (;;) {
+        std::unique_lock<std::mutex> lock(mutex);
+        work_ready.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        const std::function<void(int, int)> &fn = *job;
+        int chunk = (job_count + (int)size() - 1) / (int)size();
+        int start = (int)id * chunk;
+        int end = std::min(job_count, start + chunk);
+        lock.unlock();
+
+        if (start < end) fn(start, end);
+
+        lock.lock();
+        if (--pending == 0) work_done.notify_one();
+    }
+}
+
+// y[0..ROWS) for ROWS consecutive rows of A. Each x load feeds ROWS rows, and
+// every row keeps GEMV_LANES independent partial sums so the inner loop
+// vectorizes without reassociating a single accumulator.
+template <int ROWS>
+void matvec_rows(const float *A, const float *x, float *y, int cols)
+{
+    float acc[ROWS][GEMV_LANES] = {};
+    int c = 0;
+    for (; c + GEMV_LANES <= cols; c += GEMV_LANES) {
+        for (int i = 0; i < ROWS; i++) {
+            const float *a = A + (size_t)i * cols + c;
+            for (int l = 0; l < GEMV_LANES; l++) {
+                acc[i][l] += a[l] * x[c + l];
+            }
+        }
+    }
+    for (int i = 0; i < ROWS; i++) {
+        float sum = 0.0f;
+        for (int l = 0; l < GEMV_LANES; l++) sum += acc[i][l];
+        for (int cc = c; cc < cols; cc++) sum += A[(size_t)i * cols + cc] * x[cc];
+        y[i] = sum;
+    }
+}
+
+// Row-major GEMV over a contiguous band of rows, GEMV_ROWS at a time
+void matvec_row_block(const float *A, const float *x, float *y, int rows, int cols)
+{
+    int r = 0;
+    for (; r + GEMV_ROWS <= rows; r += GEMV_ROWS) {
+        matvec_rows<GEMV_ROWS>(A + (size_t)r * cols, x, y + r, cols);
+    }
+    for (; r < rows; r++) {
+        matvec_rows<1>(A + (size_t)r * cols, x, y + r, cols);
+    }
+}
+
+void matvec_row_major_threaded(ThreadPool &pool, const float *A, const float *x, float *y, int rows, int cols)
+{
+    pool.parallel_for(rows, [=](int start, int end) {
+        matvec_row_block(A + (size_t)start * cols, x, y + start, end - start, cols);
+    });
+}
+
+// Walk A column by column so the inner loop is a contiguous axpy over the
+// thread's rows, which the compiler vectorizes
+void matvec_col_major_threaded(ThreadPool &pool, const float *A, const float *x, float *y, int rows, int cols)
+{
+    pool.parallel_for(rows, [=](int start, int end) {
+        for (int r = start; r < end; r++) y[r] = 0.0f;
+        for (int c = 0; c < cols; c++) {
+            const float *col = A + (size_t)c * rows;
+            const float xc = x[c];
+            for (int r = start; r < end; r++) {
+                y[r] += col[r] * xc;
+            }
+        }
+    });
+}
+
+// Parallelize over every (batch, row) pair so small batches still use all
+// threads; a thread's range is split at batch boundaries and each piece runs
+// the blocked row-major GEMV against that batch's x
+void batched_gemv_threaded(ThreadPool &pool, const float *A, const float *x, float *y, int rows, int cols, int batch)
+{
+    pool.parallel_for(batch * rows, [=](int start, int end) {
+        for (int i = start; i < end;) {
+            const int b = i / rows;
+            const int stop = std::min(end, (b + 1) * rows);
+            matvec_row_block(A + (size_t)i * cols, x + (size_t)b * cols, y + i, stop - i, cols);
+            i = stop;
+        }
+    });
+}
+
+// Cache-blocked i-k-j multiply: each thread owns a band of rows of C and works
+// through CPU_BLOCK x CPU_BLOCK blocks so the active parts of A, B and C stay
+// in cache. The innermost j loop is contiguous in B and C and vectorizes.
+void matmul_blocked_threaded(ThreadPool &pool, const float *A, const float *B, float *C, int M, int N, int K)
+{
+    pool.parallel_for(M, [=](int start, int end) {
+        for (int i = start; i < end; i++)
+            for (int j = 0; j < N; j++)
+                C[(size_t)i * N + j] = 0.0f;
+
+        for (int ii = start; ii < end; ii += CPU_BLOCK) {
+            const int i_end = std::min(end, ii + CPU_BLOCK);
+            for (int kk = 0; kk < K; kk += CPU_BLOCK) {
+                const int k_end = std::min(K, kk + CPU_BLOCK);
+                for (int jj = 0; jj < N; jj += CPU_BLOCK) {
+                    const int j_end = std::min(N, jj + CPU_BLOCK);
+                    for (int i = ii; i < i_end; i++) {
+                        float *c = C + (size_t)i * N;
+                        for (int k = kk; k < k_end; k++) {
+                            const float a = A[(size_t)i * K + k];
+                            const float *b = B + (size_t)k * N;
+                            for (int j = jj; j < j_end; j++) {
+                                c[j] += a * b[j];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+// ----------------------------
+// OpenCL support code
+// ----------------------------
+cl_mem create_buffer(cl_mem_flags flags, size_t count, const float *host)
+{
+    cl_int e = 0;
+    cl_mem buf = clCreateBuffer(context, flags, count * sizeof(float), NULL, &e);
+    if (e < 0) {
+        perror("Couldn't create a buffer");
+        exit(1);
+    }
+    if (host != NULL) {
+        clEnqueueWriteBuffer(queue, buf, CL_TRUE, 0, count * sizeof(float), host, 0, NULL, NULL);
+    }
+    return buf;
+}
+
+// Work-group limit of one compiled kernel, which can be lower than the
+// device limit because of its register and local-memory use
+size_t kernel_work_group_size(const char *kernelname)
+{
+    cl_kernel k = create_kernel(kernelname);
+    size_t kernel_wg_size = 0;
+    err = clGetKernelWorkGroupInfo(k, device_id, CL_KERNEL_WORK_GROUP_SIZE, sizeof(size_t), &kernel_wg_size, NULL);
+    clReleaseKernel(k);
+    if (err < 0) {
+        perror("Couldn't query the kernel work-group size");
+        printf("kernel = %s, error = %d\n", kernelname, err);
+        exit(1);
+    }
+    return kernel_wg_size;
+}
+
+cl_kernel create_kernel(const char *kernelname)
+{
+    cl_kernel k = clCreateKernel(program, kernelname, &err);
+    if (err < 0) {
+        perror("Couldn't create a kernel");
+        printf("kernel = %s, error = %d\n", kernelname, err);
+        exit(1);
+    }
+    return k;
+}
+
+// Launch a kernel and wait for it to finish
+void run_kernel(cl_kernel k, cl_uint dims, const size_t *global, const size_t *local)
+{
+    cl_event event = NULL;
+    err = clEnqueueNDRangeKernel(queue, k, dims, NULL, global, local, 0, NULL, &event);
+    if (err < 0) {
+        perror("Couldn't enqueue the kernel");
+        printf("error = %d\n", err);
+        exit(1);
+    }
+    clWaitForEvents(1, &event);
+    clReleaseEvent(event);
+}
+
+void free_memory()
+{
+    clReleaseCommandQueue(queue);
+    clReleaseProgram(program);
+    clReleaseContext(context);
+}
+
+void setup_openCL_device_context_queue(char *filename)
+{
+    device_id = create_device();
+    cl_int err;
+
+    context = clCreateContext(NULL, 1, &device_id, NULL, NULL, &err);
+    if (err < 0) {
+        perror("Couldn't create a context");
+        exit(1);
+    }
+
+    // A TILE x TILE work-group must fit the device work-group limit and the
+    // per-dimension work-item limits along x and y; a GEMV_WG x 1 work-group
+    // must fit the work-group limit and the x limit
+    size_t max_wg_size = 0;
+    cl_uint dims = 0;
+    err = clGetDeviceInfo(device_id, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(size_t), &max_wg_size, NULL);
+    if (err == CL_SUCCESS)
+        err = clGetDeviceInfo(device_id, CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS, sizeof(cl_uint), &dims, NULL);
+    if (err < 0 || dims < 2) {
+        perror("Couldn't query the device work-group limits");
+        exit(1);
+    }
+    std::vector<size_t> item_sizes(dims);
+    err = clGetDeviceInfo(device_id, CL_DEVICE_MAX_WORK_ITEM_SIZES, dims * sizeof(size_t), item_sizes.data(), NULL);
+    if (err < 0) {
+        perror("Couldn't query the device work-item sizes");
+        exit(1);
+    }
+    size_t max_edge = std::min(item_sizes[0], item_sizes[1]);
+    while (tile > 1 && ((size_t)(tile * tile) > max_wg_size || (size_t)tile > max_edge)) tile /= 2;
+    while (gemv_wg > 1 && ((size_t)gemv_wg > max_wg_size || (size_t)gemv_wg > item_sizes[0])) gemv_wg /= 2;
+
+    // The compiled kernels can have a lower limit than the device, so check
+    // them and rebuild with a smaller TILE / GEMV_WG until both fit
+    for (;;) {
+        char options[64];
+        snprintf(options, sizeof(options), "-DTILE=%d -DGEMV_WG=%d -cl-mad-enable", tile, gemv_wg);
+        program = build_program(context, device_id, filename, options);
+
+        size_t matmul_wg_size = kernel_work_group_size("matmul_tiled");
+        size_t gemv_wg_size = std::min(kernel_work_group_size("matvec_row_major"),
+                                       kernel_work_group_size("batched_gemv"));
+
+        bool tile_fits = (size_t)(tile * tile) <= matmul_wg_size;
+        bool gemv_fits = (size_t)gemv_wg <= gemv_wg_size;
+        if (tile_fits && gemv_fits) {
+            printf("Kernel build options: %s\n", options);
+            break;
+        }
+        if ((!tile_fits && tile == 1) || (!gemv_fits && gemv_wg == 1)) {
+            printf("matrix_ops kernels don't fit any work-group size on this device\n");
+            exit(1);
+        }
+        clReleaseProgram(program);
+        while (tile > 1 && (size_t)(tile * tile) > matmul_wg_size) tile /= 2;
+        while (gemv_wg > 1 && (size_t)gemv_wg > gemv_wg_size) gemv_wg /= 2;
+    }
+
+    queue = clCreateCommandQueueWithProperties(context, device_id, 0, &err);
+    if (err < 0) {
+        perror("Couldn't create a command queue");
+        exit(1);
+    }
+}
+
+cl_program build_program(cl_context ctx, cl_device_id dev, const char *filename, const char *options)
+{
+    cl_program program;
+    FILE *program_handle;
+    char *program_buffer, *program_log;
+    size_t program_size, log_size;
+
+    program_handle = fopen(filename, "rb");
+    if (program_handle == NULL) {
+        perror("Couldn't find the program file");
+        exit(1);
+    }
+    fseek(program_handle, 0, SEEK_END);
+    program_size = ftell(program_handle);
+    rewind(program_handle);
+    program_buffer = (char *)malloc(program_size + 1);
+    program_buffer[program_size] = '\0';
+    fread(program_buffer, sizeof(char), program_size, program_handle);
+    fclose(program_handle);
+
+    program = clCreateProgramWithSource(ctx, 1, (const char **)&program_buffer, &program_size, &err);
+    if (err < 0) {
+        perror("Couldn't create the program");
+        exit(1);
+    }
+    free(program_buffer);
+
+    err = clBuildProgram(program, 0, NULL, options, NULL, NULL);
+    if (err < 0) {
+        clGetProgramBuildInfo(program, dev, CL_PROGRAM_BUILD_LOG, 0, NULL, &log_size);
+        program_log = (char *)malloc(log_size + 1);
+        program_log[log_size] = '\0';
+        clGetProgramBuildInfo(program, dev, CL_PROGRAM_BUILD_LOG, log_size + 1, program_log, NULL);
+        printf("%s\n", program_log);
+        free(program_log);
+        exit(1);
+    }
+
+    return program;
+}
+
+cl_device_id create_device() {
+    cl_platform_id platform;
+    cl_device_id dev;
+    int err;
+
+    err = clGetPlatformIDs(1, &platform, NULL);
+    if(err < 0) {
+        perror("Couldn't identify a platform");
+        exit(1);
+    }
+
+    err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, 1, &dev, NULL);
+    if(err == CL_DEVICE_NOT_FOUND) {
+        printf("GPU not found, using CPU\n");
+        err = clGetDeviceIDs(platform, CL_DEVICE_TYPE_CPU, 1, &dev, NULL);
+    }
+    if(err < 0) {
+        perror("Couldn't access any devices");
+        exit(1);
+    }
+
+    return dev;
+}
@@ -1,16 +1,41 @@
 // OpenCL kernel for parallel vector addition
-// This kernel executes on the OpenCL device with each work-item processing one vector element
+// This kernel executes on the OpenCL device with each work-item processing
+// ELEMS_PER_ITEM vector elements, one global range apart.
+//
+// The host specializes the kernel at build time with -D options:
+//   FIXED_SIZE     vector length as a compile-time constant (replaces `size`)
+//   ELEMS_PER_ITEM elements per work-item, unrolled by the compiler (default 1)
+//   EXACT_FIT      the global range covers the vector exactly, skip the bounds check
+
+#ifndef ELEMS_PER_ITEM
+#define ELEMS_PER_ITEM 1
+#endif
+
 __kernel void vector_add(const int size,
-                        __global int* v1,
-                        __global int* v2,
+                        __global const int* v1,
+                        __global const int* v2,
                         __global int* result) {
-    
-    // Get the unique global thread ID
-    const int globalIndex = get_global_id(0);
-    
-    // Ensure we don't go out of bounds
-    if (globalIndex < size) {
+
+#ifdef FIXED_SIZE
+    const int n = FIXED_SIZE;
+#else
+    const int n = size;
+#endif
+
+    // Work-item k-th element is strided by the global size, so on every
+    // iteration neighbouring work-items touch neighbouring elements and the
+    // loads/stores stay coalesced
+    const int stride = get_global_size(0);
+
+    #pragma unroll
+    for (int k = 0; k < ELEMS_PER_ITEM; k++) {
+        // Get the unique global thread ID, offset by the iteration
+        const int globalIndex = get_global_id(0) + k * stride;
+#ifndef EXACT_FIT
+        // Ensure we don't go out of bounds
+        if (globalIndex >= n) return;
+#endif
         // Perform vector addition: result[i] = v1[i] + v2[i]
         result[globalIndex] = v1[globalIndex] + v2[globalIndex];
     }
-}
\ No newline at end of file
+}
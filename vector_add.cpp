@@ -1,12 +1,30 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <CL/cl.h>
+#include <algorithm>
 #include <chrono>
 #include <thread>
 #include <vector>
 
 #define PRINT 1
 
+// Kernel variant chosen for the current run. The OpenCL program is JIT-compiled
+// per run, so the vector length and launch shape can be baked in with -D
+// options instead of being read from a kernel argument.
+struct KernelVariant {
+    int fixed_size;      // vector length passed as -DFIXED_SIZE
+    int elems_per_item;  // elements handled by each work-item (-DELEMS_PER_ITEM)
+    size_t local_size;   // work-group size, 0 lets the runtime decide
+    bool exact_fit;      // global range covers SZ exactly, bounds check dropped
+};
+
+// Candidate work-group sizes and per-item unroll factors, tightest first
+constexpr size_t WG_SIZE_CLASSES[] = {256, 128, 64, 32};
+constexpr int UNROLL_CLASSES[] = {4, 2};
+
+// Kernel launches per timing: one warm-up, then the best of KERNEL_REPS
+constexpr int KERNEL_REPS = 10;
+
 int SZ = 1000000;  // Larger size for performance comparison
 int *v1, *v2, *result_opencl, *result_threaded;
 
@@ -19,24 +37,37 @@ cl_kernel kernel;
 cl_command_queue queue;
 cl_event event = NULL;
 int err;
+KernelVariant variant;
 
 // Function declarations
 cl_device_id create_device();
 void setup_openCL_device_context_queue_kernel(char *filename, char *kernelname);
-cl_program build_program(cl_context ctx, cl_device_id dev, const char *filename);
+cl_program build_program(cl_context ctx, cl_device_id dev, const char *filename, const char *options);
+KernelVariant choose_kernel_variant(int size, size_t wg_limit);
+void format_build_options(const KernelVariant &kv, char *out, size_t len);
+size_t device_work_group_limit(cl_device_id dev);
+void enqueue_kernel(cl_kernel k, const size_t *global, const size_t *local, cl_event *ev);
+double time_kernel(cl_kernel k, const size_t *global, const size_t *local);
 void setup_kernel_memory();
-void copy_kernel_args();
+void copy_kernel_args(cl_kernel k);
 void free_memory();
 void init_vectors(int size);
 void print_vectors(int *A, int *B, int *C, int size);
 void vector_add_threaded(int num_threads);
 void vector_add_worker(int start, int end);
+bool vector_add_fixed_dispatch(int size);
 
 int main(int argc, char **argv)
 {
     if (argc > 1)
         SZ = atoi(argv[1]);
 
+    if (SZ <= 0) {
+        printf("Usage: %s [vector_size]\n", argv[0]);
+        printf("  vector_size must be positive\n");
+        return 1;
+    }
+
     init_vectors(SZ);
     
     printf("Vector Addition Performance Comparison\n");
@@ -46,13 +77,16 @@ int main(int argc, char **argv)
     // OpenCL Implementation
     auto start_opencl = std::chrono::high_resolution_clock::now();
     
-    size_t global[1] = {(size_t)SZ};
-    
     setup_openCL_device_context_queue_kernel((char *)"./vector_add.cl", (char *)"vector_add");
     setup_kernel_memory();
-    copy_kernel_args();
+    copy_kernel_args(kernel);
     
-    clEnqueueNDRangeKernel(queue, kernel, 1, NULL, global, NULL, 0, NULL, &event);
+    // An exact-fit variant covers SZ with whole work-groups of unrolled items;
+    // otherwise one work-item per element and the kernel keeps its bounds check
+    size_t global[1] = {(size_t)(SZ / variant.elems_per_item)};
+    size_t local[1] = {variant.local_size};
+    
+    enqueue_kernel(kernel, global, variant.local_size ? local : NULL, &event);
     clWaitForEvents(1, &event);
     clEnqueueReadBuffer(queue, bufResult, CL_TRUE, 0, SZ * sizeof(int), &result_opencl[0], 0, NULL, NULL);
     
@@ -61,19 +95,43 @@ int main(int argc, char **argv)
     
     printf("OpenCL Execution Time: %ld microseconds\n", duration_opencl.count());
     
-    // Multi-threaded Implementation
+    // Kernel-only timing of the specialized variant against the same kernel
+    // built without -D options and launched with a runtime-chosen local size
+    cl_program generic_program = build_program(context, device_id, "./vector_add.cl", "");
+    cl_kernel generic_kernel = clCreateKernel(generic_program, "vector_add", &err);
+    if (err < 0) {
+        perror("Couldn't create the generic kernel");
+        exit(1);
+    }
+    copy_kernel_args(generic_kernel);
+    size_t generic_global[1] = {(size_t)SZ};
+    
+    double specialized_us = time_kernel(kernel, global, variant.local_size ? local : NULL);
+    double generic_us = time_kernel(generic_kernel, generic_global, NULL);
+    printf("Kernel Time (specialized): %.1f microseconds\n", specialized_us);
+    printf("Kernel Time (generic):     %.1f microseconds\n", generic_us);
+    
+    clReleaseKernel(generic_kernel);
+    clReleaseProgram(generic_program);
+    
+    // CPU Implementation: small power-of-two sizes run the fixed-size loop on
+    // one thread, everything else is split across hardware threads
     auto start_threaded = std::chrono::high_resolution_clock::now();
     
-    vector_add_threaded(std::thread::hardware_concurrency());
+    bool fixed_size = vector_add_fixed_dispatch(SZ);
+    if (!fixed_size) {
+        vector_add_threaded(std::thread::hardware_concurrency());
+    }
     
     auto end_threaded = std::chrono::high_resolution_clock::now();
     auto duration_threaded = std::chrono::duration_cast<std::chrono::microseconds>(end_threaded - start_threaded);
     
-    printf("Multi-threaded Execution Time: %ld microseconds\n", duration_threaded.count());
+    const char *cpu_label = fixed_size ? "Fixed-size single-thread" : "Multi-threaded";
+    printf("%s Execution Time: %ld microseconds\n", cpu_label, duration_threaded.count());
     
     // Performance comparison
     double speedup = (double)duration_threaded.count() / duration_opencl.count();
-    printf("OpenCL Speedup: %.2fx\n", speedup);
+    printf("OpenCL Speedup (vs %s): %.2fx\n", cpu_label, speedup);
     
     // Verify results match
     bool results_match = true;
@@ -127,6 +185,34 @@ void print_vectors(int *A, int *B, int *C, int size)
     printf("\n");
 }
 
+// Fixed-size CPU loop: N is a compile-time constant, so the compiler can fully
+// unroll and vectorize it without a runtime trip count
+template <int N>
+void vector_add_fixed(const int *A, const int *B, int *C)
+{
+    for (int i = 0; i < N; i++) {
+        C[i] = A[i] + B[i];
+    }
+}
+
+// Run the specialized loop if size matches one of the small size classes.
+// For these sizes spawning threads costs far more than the additions, so
+// main() runs this instead of the threaded version.
+bool vector_add_fixed_dispatch(int size)
+{
+    switch (size) {
+        case 8:    vector_add_fixed<8>(v1, v2, result_threaded);    return true;
+        case 16:   vector_add_fixed<16>(v1, v2, result_threaded);   return true;
+        case 32:   vector_add_fixed<32>(v1, v2, result_threaded);   return true;
+        case 64:   vector_add_fixed<64>(v1, v2, result_threaded);   return true;
+        case 128:  vector_add_fixed<128>(v1, v2, result_threaded);  return true;
+        case 256:  vector_add_fixed<256>(v1, v2, result_threaded);  return true;
+        case 512:  vector_add_fixed<512>(v1, v2, result_threaded);  return true;
+        case 1024: vector_add_fixed<1024>(v1, v2, result_threaded); return true;
+        default:   return false;
+    }
+}
+
 void vector_add_threaded(int num_threads)
 {
     std::vector<std::thread> threads;
@@ -166,12 +252,42 @@ void free_memory()
     free(result_threaded);
 }
 
-void copy_kernel_args()
+void copy_kernel_args(cl_kernel k)
 {
-    clSetKernelArg(kernel, 0, sizeof(int), (void *)&SZ);
-    clSetKernelArg(kernel, 1, sizeof(cl_mem), (void *)&bufV1);
-    clSetKernelArg(kernel, 2, sizeof(cl_mem), (void *)&bufV2);
-    clSetKernelArg(kernel, 3, sizeof(cl_mem), (void *)&bufResult);
+    clSetKernelArg(k, 0, sizeof(int), (void *)&SZ);
+    clSetKernelArg(k, 1, sizeof(cl_mem), (void *)&bufV1);
+    clSetKernelArg(k, 2, sizeof(cl_mem), (void *)&bufV2);
+    clSetKernelArg(k, 3, sizeof(cl_mem), (void *)&bufResult);
+}
+
+// Enqueue a 1-D launch, exiting if the runtime rejects the range or local size
+void enqueue_kernel(cl_kernel k, const size_t *global, const size_t *local, cl_event *ev)
+{
+    cl_int e = clEnqueueNDRangeKernel(queue, k, 1, NULL, global, local, 0, NULL, ev);
+    if (e < 0) {
+        perror("Couldn't enqueue the kernel");
+        printf("error = %d, global = %zu, local = %zu\n", e, global[0], local ? local[0] : (size_t)0);
+        exit(1);
+    }
+}
+
+// Launch once to absorb lazy driver work, then return the best of
+// KERNEL_REPS launches in microseconds
+double time_kernel(cl_kernel k, const size_t *global, const size_t *local)
+{
+    double best = 0.0;
+    for (int rep = 0; rep <= KERNEL_REPS; rep++) {
+        cl_event ev = NULL;
+        auto t0 = std::chrono::high_resolution_clock::now();
+        enqueue_kernel(k, global, local, &ev);
+        clWaitForEvents(1, &ev);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        clReleaseEvent(ev);
+        double us = std::chrono::duration<double, std::micro>(t1 - t0).count();
+        if (rep == 0) continue;
+        if (rep == 1 || us < best) best = us;
+    }
+    return best;
 }
 
 void setup_kernel_memory()
@@ -195,22 +311,107 @@ void setup_openCL_device_context_queue_kernel(char *filename, char *kernelname)
         exit(1);
     }
 
-    program = build_program(context, device_id, filename);
+    char options[256];
+    variant = choose_kernel_variant(SZ, device_work_group_limit(device_id));
+
+    // The compiled kernel can have a lower work-group limit than the device
+    // (registers, local memory); if the exact-fit local size doesn't fit it,
+    // rebuild as the generic variant and let the runtime pick the local size
+    for (;;) {
+        format_build_options(variant, options, sizeof(options));
+        program = build_program(context, device_id, filename, options);
+
+        kernel = clCreateKernel(program, kernelname, &err);
+        if (err < 0) {
+            perror("Couldn't create a kernel");
+            exit(1);
+        }
+        if (variant.local_size == 0) break;
+
+        size_t kernel_wg_size = 0;
+        err = clGetKernelWorkGroupInfo(kernel, device_id, CL_KERNEL_WORK_GROUP_SIZE, sizeof(size_t), &kernel_wg_size, NULL);
+        if (err < 0) {
+            perror("Couldn't query the kernel work-group size");
+            exit(1);
+        }
+        if (variant.local_size <= kernel_wg_size) break;
+
+        clReleaseKernel(kernel);
+        clReleaseProgram(program);
+        variant = choose_kernel_variant(SZ, 0);
+    }
+    printf("Kernel build options: %s\n", options);
 
     queue = clCreateCommandQueueWithProperties(context, device_id, 0, &err);
     if (err < 0) {
         perror("Couldn't create a command queue");
         exit(1);
     }
+}
 
-    kernel = clCreateKernel(program, kernelname, &err);
-    if (err < 0) {
-        perror("Couldn't create a kernel");
+// Largest 1-D work-group the device accepts: the smaller of the total
+// work-group limit and the limit along dimension 0
+size_t device_work_group_limit(cl_device_id dev)
+{
+    size_t max_wg_size = 0;
+    cl_uint dims = 0;
+    cl_int e = clGetDeviceInfo(dev, CL_DEVICE_MAX_WORK_GROUP_SIZE, sizeof(size_t), &max_wg_size, NULL);
+    if (e == CL_SUCCESS)
+        e = clGetDeviceInfo(dev, CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS, sizeof(cl_uint), &dims, NULL);
+    if (e < 0 || dims == 0) {
+        perror("Couldn't query the device work-group limits");
+        exit(1);
+    }
+
+    std::vector<size_t> item_sizes(dims);
+    e = clGetDeviceInfo(dev, CL_DEVICE_MAX_WORK_ITEM_SIZES, dims * sizeof(size_t), item_sizes.data(), NULL);
+    if (e < 0) {
+        perror("Couldn't query the device work-item sizes");
         exit(1);
     }
+
+    return std::min(max_wg_size, item_sizes[0]);
+}
+
+// Pick the tightest kernel variant for this size. Only the largest work-group
+// class the device allows is considered, so an exact-fit launch never uses a
+// smaller work-group than the runtime would pick on its own; with it, use the
+// largest unroll factor that still divides the size. Otherwise fall back to a
+// bounds-checked one-element-per-item launch with a runtime-chosen local size,
+// which is also what a wg_limit of 0 or a non-positive size gets.
+KernelVariant choose_kernel_variant(int size, size_t wg_limit)
+{
+    KernelVariant kv = {size, 1, 0, false};
+    if (size <= 0) return kv;
+
+    size_t wg = 0;
+    for (size_t candidate : WG_SIZE_CLASSES) {
+        if (candidate <= wg_limit) {
+            wg = candidate;
+            break;
+        }
+    }
+    if (wg == 0 || size % (int)wg != 0) return kv;
+
+    kv.local_size = wg;
+    kv.exact_fit = true;
+    for (int unroll : UNROLL_CLASSES) {
+        if (size % (int)(wg * unroll) == 0) {
+            kv.elems_per_item = unroll;
+            break;
+        }
+    }
+    return kv;
+}
+
+void format_build_options(const KernelVariant &kv, char *out, size_t len)
+{
+    snprintf(out, len, "-DFIXED_SIZE=%d -DELEMS_PER_ITEM=%d%s",
+             kv.fixed_size, kv.elems_per_item,
+             kv.exact_fit ? " -DEXACT_FIT" : "");
 }
 
-cl_program build_program(cl_context ctx, cl_device_id dev, const char *filename)
+cl_program build_program(cl_context ctx, cl_device_id dev, const char *filename, const char *options)
 {
     cl_program program;
     FILE *program_handle;
@@ -237,7 +438,7 @@ cl_program build_program(cl_context ctx, cl_device_id dev, const char *filename)
     }
     free(program_buffer);
 
-    err = clBuildProgram(program, 0, NULL, NULL, NULL, NULL);
+    err = clBuildProgram(program, 0, NULL, options, NULL, NULL);
     if (err < 0) {
         clGetProgramBuildInfo(program, dev, CL_PROGRAM_BUILD_LOG, 0, NULL, &log_size);
         program_log = (char *)malloc(log_size + 1);